@@ -18,9 +18,13 @@ html_attribute <- function(name, value = NULL) {
 }
 escape_attr <- function(x) {
   x <- escape.character(x)
-  x <- gsub("\'", '&#39;', x)
-  x <- gsub("\"", '&quot;', x)
-  x <- gsub("\r", '&#13;', x)
-  x <- gsub("\n", '&#10;', x)
+  # Most values don't contain any of these characters, so check once
+  # instead of making four passes
+  if (!grepl("['\"\r\n]", x)) return(x)
+
+  x <- gsub("\'", '&#39;', x, fixed = TRUE)
+  x <- gsub("\"", '&quot;', x, fixed = TRUE)
+  x <- gsub("\r", '&#13;', x, fixed = TRUE)
+  x <- gsub("\n", '&#10;', x, fixed = TRUE)
   x
 }
@@ -1,21 +1,24 @@
-read_delim <- function(file, header = TRUE, sep = ",") {
+# A simple delimited file reader. Column types are guessed from the first
+# `guess_max` rows and each field is parsed straight into its type. If a later
+# row doesn't fit the guessed types, the data is re-read (with a warning) as
+# character and converted with type.convert(), so any well-formed file can be
+# read.
+
+read_delim <- function(file, header = TRUE, sep = ",", guess_max = 1000) {
   # Determine number of fields by reading first line
   first <- scan(
     file, what = character(1), nlines = 1,
     sep = sep, quiet = TRUE
   )
   p <- length(first)
+  skip <- if (header) 1 else 0
 
-  # Load all fields as character vectors
-  all <- scan(
-    file, what = as.list(character(p)), sep = sep,
-    skip = if (header) 1 else 0, quiet = TRUE
-  )
-  gc()
+  # Guess column types from the first few rows
+  types <- guess_types(file, p, sep = sep, skip = skip, n = guess_max)
 
-  # Convert from strings to appropriate types (never to factors)
-  all[] <- lapply(all, type.convert, as.is = TRUE)
-  gc()
+  # Parse every field directly into the right type: only character columns
+  # create strings
+  all <- scan_typed(types, sep = sep, file = file, skip = skip)
 
   # Set column names
   if (header) {
@@ -25,5 +28,73 @@ read_delim <- function(file, header = TRUE, sep = ",") {
   }
 
   # Convert list into data frame
-  as.data.frame(all)
+  as.data.frame(all, stringsAsFactors = FALSE)
+}
+
+# Like read_delim(), but instead of returning everything at once, calls
+# `callback` with a data frame of (at most) `chunk_size` rows at a time.
+# This makes it possible to process files that are too big for memory.
+# A chunk that doesn't fit the guessed types has its own types worked out
+# by type.convert(), so column types might differ between chunks.
+read_delim_chunked <- function(file, callback, chunk_size = 1e5,
+                               header = TRUE, sep = ",", guess_max = 1000) {
+  first <- scan(
+    file, what = character(1), nlines = 1,
+    sep = sep, quiet = TRUE
+  )
+  p <- length(first)
+  skip <- if (header) 1 else 0
+  types <- guess_types(file, p, sep = sep, skip = skip, n = guess_max)
+  col_names <- if (header) first else paste0("V", seq_len(p))
+
+  con <- file(file, "r")
+  on.exit(close(con), add = TRUE)
+  if (header) readLines(con, n = 1)
+
+  repeat {
+    lines <- readLines(con, n = chunk_size)
+    if (length(lines) == 0) break
+
+    chunk <- scan_typed(types, sep = sep, text = lines)
+    names(chunk) <- col_names
+    callback(as.data.frame(chunk, stringsAsFactors = FALSE))
+  }
+
+  invisible()
+}
+
+guess_types <- function(file, p, sep, skip, n) {
+  sample <- scan(
+    file, what = as.list(character(p)), sep = sep,
+    skip = skip, nmax = n, quiet = TRUE
+  )
+
+  lapply(sample, function(x) {
+    type <- typeof(type.convert(x, as.is = TRUE))
+    # A column that's entirely missing in the first n rows could contain
+    # anything later
+    if (type == "logical" && all(is.na(x) | x == "")) type <- "character"
+    vector(type)
+  })
+}
+
+# Parse with the guessed types, falling back to reading every column as
+# character if a field doesn't fit. `...` supplies either `file` and `skip`,
+# or `text`
+scan_typed <- function(types, sep, ...) {
+  tryCatch(
+    scan(..., what = types, sep = sep, quiet = TRUE),
+    error = function(e) {
+      warning(
+        "Guessed column types don't fit all rows; re-reading as character.\n",
+        "Increase `guess_max` to avoid this.",
+        call. = FALSE
+      )
+      all <- scan(
+        ..., what = lapply(types, function(x) character()),
+        sep = sep, quiet = TRUE
+      )
+      lapply(all, type.convert, as.is = TRUE)
+    }
+  )
 }